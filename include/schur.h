@@ -9,10 +9,18 @@
 #include <vector>
 #include <cassert>
 
+struct NDlevel;
+struct VecBufBlock;
+
+//The first split ranks of a level form its low half.
 struct RSDnode {
   RSDnode* child;
+  int depth;
   int rankForCurrLevel;
   int npesForCurrLevel;
+  int split;
+  MPI_Comm comm;
+  NDlevel* nd;
 };
 
 struct VecBufType1 {
@@ -74,9 +82,93 @@ struct VecBufType5 {
   Vec gH;
 };
 
+//Persistent request of one MPI tag and direction. It is bound to the
+//channel's own staging buffer and only rebound when the length, peer or
+//precision of the message changes.
+struct MsgChannel {
+  MPI_Request request;
+  bool active;
+  std::vector<double> doubleBuf;
+  std::vector<float> floatBuf;
+  void* boundBuf;
+  int boundLen;
+  MPI_Datatype boundType;
+  int boundPeer;
+  MPI_Comm boundComm;
+  PetscScalar* recvArr;
+  int numMsgs;
+  double numBytes;
+  double waitTime;
+};
+
+//Interface message channels, indexed by MPI tag
+struct MsgBufType {
+  MsgChannel send[9];
+  MsgChannel recv[9];
+};
+
+//Kernels timed by the profiler (-rsd_profile) and logged as PETSc events
+enum ProfKernel {
+  PROF_LOCAL_SOLVE, PROF_MAP, PROF_SCHUR_KSP, PROF_SCHUR_MATVEC, PROF_KMATVEC,
+  PROF_INTERFACE_WAIT, PROF_COARSE, PROF_OUTER_REDUCE, PROF_IFACE_SCHUR_MATVEC,
+  NUM_PROF_KERNELS
+};
+
+//Kernel times are inclusive and only the outermost call of a recursive
+//kernel is timed. levelTime[d] is the inclusive time of the RSD
+//preconditioner at depth d and levelWait[d] the interface waits issued
+//directly at that depth.
+struct ProfileData {
+  bool enabled;
+  int kernelNesting[NUM_PROF_KERNELS];
+  double kernelStart[NUM_PROF_KERNELS];
+  double kernelTime[NUM_PROF_KERNELS];
+  std::vector<double> levelStart;
+  std::vector<double> levelTime;
+  std::vector<double> levelWait;
+  int currDepth;
+  double tagWait[9];
+};
+
+//Fast direct solver for the local Dirichlet problem on the Nx x N strip
+//(-loc_fast_solve). A sine transform along every column (length N - 2, an
+//FFT of length 2*(N - 1)) decouples the sine modes; each mode is then one
+//tridiagonal system across the Nx - 2 interior columns, factored once.
+//Index of the factors: (((d*numModes) + k)*numCols) + i for component d,
+//mode k and interior column i.
+template<typename Real>
+struct FastSolveTables {
+  std::vector<Real> cosTab;
+  std::vector<Real> sinTab;
+  std::vector<Real> lower;
+  std::vector<Real> upperFactor;
+  std::vector<Real> invPivot;
+  std::vector<Real> modes;
+  std::vector<Real> fftRe;
+  std::vector<Real> fftIm;
+};
+
+//single holds float copies of the tables, made on the first single
+//precision solve (see LocalData::inSinglePrecisionPC)
+struct FastLocalSolver {
+  int N;
+  int Nx;
+  int dofs;
+  int numModes;
+  int numCols;
+  int fftLen;
+  std::vector<int> bitRev;
+  FastSolveTables<double> dbl;
+  FastSolveTables<float> single;
+};
+
 struct LocalData {
   int N;
   int dofsPerNode;
+  int rank, npes;
+  int nx;
+  int oxs, onx;
+  std::vector<double> stripCost;
   MPI_Comm commAll, commLow, commHigh;
   Mat Kssl, Kssh;
   Mat Ksl, Ksh;
@@ -84,7 +176,31 @@ struct LocalData {
   Mat Kll, Khh;
   Mat lowSchurMat, highSchurMat;
   KSP lowSchurKsp, highSchurKsp;
+  bool useExplicitSchur;
+  Mat explicitLowSchur;
+  int probeBandwidth;
+  Mat lowSchurBand;
+  bool useAdditiveRSD;
+  bool useNestedRSD;
+  bool compareNestedRSD;
+  bool useMatFreeStencil;
+  std::vector<double> nodeStencil;
+  bool useMixedPrecision;
+  //True while the preconditioner runs with -mixed_precision: the fast local
+  //solves and the matrix-free coupling products are then done in float
+  bool inSinglePrecisionPC;
+  MsgBufType* msgBuf;
+  double commSetupTime;
+  bool useSetupCache;
+  bool setupCacheHit;
+  int setupCacheSolverKey;
+  char setupCachePrefix[PETSC_MAX_PATH_LEN];
+  void* explicitSchurMap;
+  size_t explicitSchurMapLen;
+  ProfileData* prof;
   DMMG* mgObj;
+  FastLocalSolver* fastSolver;
+  long long numLocalSolves;
   VecBufType1* buf1;
   VecBufType1* buf2; 
   VecBufType1* buf3; 
@@ -92,6 +208,207 @@ struct LocalData {
   VecBufType3* buf5;
   VecBufType4* buf6;
   VecBufType5* buf7;
+  VecBufType1* buf8;
+  VecBufBlock* blockBuf;
+  std::vector<PetscScalar> workspace;
+  std::vector<Vec*> workVecs;
+  int pcWorkLen, matVecWorkLen;
+};
+
+//Context of the matrix-free shells that replace the interface matrices.
+//useSingle points at LocalData::inSinglePrecisionPC (NULL: always double).
+struct EdgeStencilCtx {
+  int N;
+  int dofsPerNode;
+  bool dirichletDiag;
+  std::vector<double> blocks;
+  std::vector<float> blocksSingle;
+  const bool* useSingle;
+};
+
+typedef void (*EdgeMatCreator)(int N, int dofsPerNode, int numTerms, const int rowIds[][2],
+    const int colIds[][2], bool dirichletDiag, Mat* mat);
+
+//Per-level state of the nested-dissection mode (-rsd_nested). schurKsp runs
+//on the subtree communicator and halfKsp on the child's communicator.
+struct NDlevel {
+  LocalData* data;
+  RSDnode* node;
+  MPI_Comm childComm;
+  bool isLow;
+  bool isHigh;
+  Mat schurMat;
+  KSP schurKsp;
+  Vec schurRhs;
+  Vec schurSol;
+  Mat halfMat;
+  KSP halfKsp;
+  Vec halfRhsKsp;
+  Vec halfSolKsp;
+  Vec fTmp;
+  Vec halfRhs;
+  Vec halfSol;
+  Vec inSeq;
+  Vec outSeq;
+  Vec uS;
+  Vec gS;
+  Vec col;
+  Vec wS;
+  Vec uStar;
+  Vec recvS;
+  Vec sInSeq;
+  Vec sOutSeq;
+};
+
+struct BlockKrylovOps {
+  void (*applyA)(void* ctx, int k, Vec* in, Vec* out);
+  void (*applyM)(void* ctx, int k, Vec* in, Vec* out);
+  void* ctx;
+};
+
+//Krylov basis of blockFgmres: V[c] holds restart + 1 and Z[c] restart
+//vectors for column c. Kept between calls and only grown.
+struct BlockKrylovWork {
+  std::vector<std::vector<Vec> > V;
+  std::vector<std::vector<Vec> > Z;
+};
+
+//Work space of the block kernels, the k-column counterparts of buf5
+//(schurMatVecBlock), buf6 (KmatVecBlock) and buf7 (RSDapplyInverseBlock).
+//Like those it is created on first use; the k-column vectors and the packed
+//message buffers are only grown when a call has more columns. The receive
+//buffers are per kernel and side, since a receive can be in flight while
+//the kernel recurses or runs an inner solve.
+struct VecBufBlock {
+  std::vector<PetscScalar> sendBuf;
+  std::vector<PetscScalar> recvS3;
+  std::vector<PetscScalar> recvS4;
+  std::vector<PetscScalar> recv5;
+  std::vector<PetscScalar> recv6;
+  std::vector<PetscScalar> recv7;
+  std::vector<PetscScalar> recv8;
+  //schurMatVecBlock
+  Vec uL;
+  Vec vL;
+  Vec wL;
+  Vec wSl;
+  Vec uSinCopy;
+  Vec uH;
+  Vec vH;
+  Vec wH;
+  Vec wSh;
+  std::vector<Vec> uStarH;
+  //schurSolveBlock on the high rank, which owns no rows of S
+  std::vector<Vec> emptyRhs;
+  std::vector<Vec> emptySol;
+  BlockKrylovWork lowKrylov;
+  BlockKrylovWork highKrylov;
+  //KmatVecBlock
+  Vec kuSl;
+  Vec kuL;
+  Vec kwSl;
+  Vec kbSl;
+  Vec kcL;
+  Vec kcOl;
+  std::vector<Vec> kySl;
+  Vec kuSh;
+  Vec kuH;
+  Vec kwSh;
+  Vec kcH;
+  Vec kcOh;
+  std::vector<Vec> kbSh;
+  //RSDapplyInverseBlock
+  std::vector<Vec> fTmpL;
+  std::vector<Vec> fTmpH;
+  std::vector<Vec> gS;
+  std::vector<Vec> uS;
+  std::vector<Vec> fStarH;
+  Vec fL;
+  Vec fStarL;
+  Vec gL;
+  Vec fH;
+  Vec fStarHcopy;
+  Vec gH;
+  //localSolveBlock (MG ordering)
+  std::vector<Vec> rhsMg;
+  std::vector<Vec> solMg;
+  Mat rhsDense;
+  Mat solDense;
+  int denseCols;
+  BlockKrylovWork outerKrylov;
+};
+
+//Global coarse space (-coarse_space). Every interface i (between ranks i
+//and i + 1) contributes numModes sine modes per dof along the interface,
+//extended harmonically into both neighbouring strips. phiL holds this
+//rank's part of the basis of interface rank (this rank is the low side)
+//and phiH its part of the basis of interface (rank - 1). The Galerkin
+//coarse matrix is block tridiagonal and is owned by the low rank of each
+//interface.
+struct CoarseSpace {
+  int numModes;
+  int numPerInterface;
+  bool additive;
+  std::vector<Vec> phiL;
+  std::vector<Vec> phiH;
+  std::vector<PetscScalar> coeffs;
+  Mat coarseMat;
+  KSP coarseKsp;
+  Vec coarseRhs;
+  Vec coarseSol;
+  Vec coarseLocal;
+  VecScatter toLocal;
+  Vec inSeq;
+  Vec outSeq;
+  Vec uC;
+  Vec rC;
+  double setupTime;
+};
+
+//Interface-only outer iteration (-interface_schur). The unknowns are the
+//interface columns S, one per rank except the last. rhs and sol are the
+//global interface vectors; the sequential vectors are work space of
+//N*dofs entries (inSeq and outSeq have no storage of their own).
+struct InterfaceSchur {
+  Mat mat;
+  KSP ksp;
+  PC pc;
+  Vec rhs;
+  Vec sol;
+  Vec inSeq;
+  Vec outSeq;
+  Vec uLeft;
+  Vec recvS;
+  Vec uStarH;
+  Vec workS;
+  Vec workL;
+  Vec workH;
+  double condenseTime;
+  double recoverTime;
+};
+
+//Adaptive inner Schur tolerances (-inner_adapt). At outer iteration k with
+//residual r_k the inner rtol at tree depth d is
+//min(maxRtol, scale*eps*max(1, r_0/r_k)*depthFactor^d): the inner solves
+//are relaxed as the outer residual goes down (inexact Krylov) and deeper
+//interfaces are solved less accurately. scale drops by 10 whenever an
+//outer iteration reduces the residual by less than the factor stagnation.
+//The inner max_it is left as set (-inner_ksp_max_it), so no solve does
+//more inner iterations than the fixed mode. lowDepth and highDepth are the
+//depths of this rank's interfaces (-1 if none).
+struct InnerAdapt {
+  int lowDepth;
+  int highDepth;
+  int maxDepth;
+  PetscReal eps;
+  PetscReal maxRtol;
+  PetscReal depthFactor;
+  PetscReal stagnation;
+  PetscReal r0;
+  PetscReal prevNorm;
+  PetscReal scale;
+  int lastIt;
+  bool monitor;
 };
 
 struct OuterContext {
@@ -102,8 +419,37 @@ struct OuterContext {
   PC outerPC;
   Vec outerSol;
   Vec outerRhs;
+  CoarseSpace* coarse;
+  InterfaceSchur* iface;
+  InnerAdapt* adapt;
+  bool usePipelinedOuter;
+};
+
+//Handle for a sequence of solves with the same operator (time stepping).
+//prevSols holds the last solutions, most recent first, for the
+//extrapolated initial guess. With recycling, recycleC = A recycleU has
+//orthonormal columns; the outer PC is deflated with it and every solve
+//adds the correction it found to the space.
+struct RSDSolver {
+  OuterContext* ctx;
+  bool ownsContext;
+  int guessOrder;
+  std::vector<Vec> prevSols;
+  int numPrevSols;
+  int maxRecycle;
+  std::vector<Vec> recycleU;
+  std::vector<Vec> recycleC;
+  std::vector<PetscScalar> coeffs;
+  Vec guess;
+  Vec work;
+  int numSolves;
+  int lastIterations;
+  int totalIterations;
+  double lastSolveTime;
 };
 
+//MG and O are numbered x-major: node (xi, yi) is at (xi*N) + yi. MG has
+//nx columns of N nodes; nx = N unless the strips are balanced.
 //MG = Multigrid (includes 0 dirichlet on both ends)
 //O = Owned = S + V
 //V = Volume or Interior (includes domain boundaries)
@@ -128,6 +474,8 @@ void createHardStencilType1();
 
 void createHardStencilType2();
 
+void createStencil(int problem);
+
 void destroyStencil();
 
 double Phi(int i, double psi, double eta);
@@ -148,6 +496,88 @@ void destroyLocalData(LocalData* data);
 
 void createLocalMatrices(LocalData* data);
 
+void createLocalMatricesLegacy(LocalData* data);
+
+void createBlockedLocalMatrices(LocalData* data, EdgeMatCreator createEdge);
+
+void computeEdgeBlocks(int dofsPerNode, int numTerms, const int rowIds[][2],
+    const int colIds[][2], std::vector<double> & blocks);
+
+void createEdgeMatrix(int N, int dofsPerNode, int numTerms, const int rowIds[][2],
+    const int colIds[][2], bool dirichletDiag, Mat* mat);
+
+void createEdgeShell(int N, int dofsPerNode, int numTerms, const int rowIds[][2],
+    const int colIds[][2], bool dirichletDiag, Mat* mat);
+
+PetscErrorCode edgeStencilMatMult(Mat mat, Vec in, Vec out);
+
+//Points the coupling shells at LocalData::inSinglePrecisionPC
+void linkEdgeShells(LocalData* data);
+
+//Applies the finest MG operator directly to an owned (O) vector (-matfree_stencil)
+void ownedStencilMatVec(LocalData* data, Vec in, Vec out);
+
+//Seconds per application of the owned stencil kernel to an interior strip
+//of N columns. Used by -strip_balance to estimate the speed of a rank.
+double timeStencilSweeps(LocalData* data, int numSweeps);
+
+//Destroys one of Kssl, Kssh, ... and its shell context if it has one
+void destroyLocalMatrix(LocalData* data, Mat mat);
+
+//Creates the buffers of buf1 to buf8 up front. The buffers of the outer
+//MatVec (KmatVec) and of the preconditioner (RSDapplyInverse, schurSolve,
+//schurMatVec) are never live together and share one arena.
+void createWorkspace(LocalData* data);
+
+//Destroys every buffer of buf1 to buf8, including the ones created lazily
+void destroyWorkspace(LocalData* data);
+
+//Bytes per rank held by the local matrices, the DMMG levels, the workspace
+//and the message buffers (-memory_report)
+void printMemoryReport(OuterContext* ctx);
+
+void createInterfaceChannels(LocalData* data);
+
+void destroyInterfaceChannels(LocalData* data);
+
+void interfaceIsend(LocalData* data, PetscScalar* arr, int len, int dest, 
+    int tag, MPI_Comm comm);
+
+void interfaceIrecv(LocalData* data, PetscScalar* arr, int len, int src, 
+    int tag, MPI_Comm comm);
+
+void interfaceWaitSend(LocalData* data, int tag);
+
+void interfaceWaitRecv(LocalData* data, int tag);
+
+//Zeros the message counters, e.g. to leave out the setup MatVecs
+void resetInterfaceStats(LocalData* data);
+
+//Prints messages, bytes and wait times per tag over all ranks (-comm_stats)
+void printInterfaceStats(LocalData* data);
+
+void createProfile(LocalData* data);
+
+void destroyProfile(LocalData* data);
+
+void profileBegin(LocalData* data, ProfKernel kernel);
+
+void profileEnd(LocalData* data, ProfKernel kernel);
+
+void profileEnterLevel(LocalData* data, int depth);
+
+void profileExitLevel(LocalData* data, int depth);
+
+void profileAddWait(LocalData* data, int tag, double waitTime);
+
+void resetProfile(LocalData* data);
+
+//Min, mean and max over ranks of the level, kernel and tag wait times (-rsd_profile)
+void printProfile(LocalData* data);
+
+//Prints the setup time of the legacy and the blocked assembly (-assembly_compare)
+void compareAssembly(LocalData* data);
+
 void createOuterMat(OuterContext* ctx);
 
 PetscErrorCode outerMatMult(Mat mat, Vec in, Vec out);
@@ -162,6 +592,15 @@ void createMG(LocalData* data);
 
 PetscErrorCode computeMGmatrix(DMMG dmmg, Mat J, Mat B);
 
+PetscErrorCode computeMGmatrixLegacy(DMMG dmmg, Mat J, Mat B);
+
+PetscErrorCode computeMGmatrixBlocked(DMMG dmmg, Mat J, Mat B);
+
+void computeNodeStencil(int dofsPerNode, std::vector<double> & nodeStencil);
+
+int computeMGblockRow(int Nx, int N, int dofsPerNode, const std::vector<double> & nodeStencil,
+    int xi, int yi, int* cols, double* vals);
+
 void createOuterPC(OuterContext* ctx); 
 
 PetscErrorCode outerPCapply(void* ctx, Vec in, Vec out);
@@ -170,10 +609,78 @@ void createOuterKsp(OuterContext* ctx);
 
 void createInnerKsp(LocalData* data);
 
-void createRSDtree(RSDnode *& root, int rank, int npes);
+//Decides whether the Schur products are read from the per-rank setup cache
+//(-setup_cache <prefix>). All ranks hit or all ranks rebuild. The assembled
+//matrices are cached per rank (see loadInterfaceMatrixCache).
+void openSetupCache(LocalData* data);
+
+//Maps len cached scalars of the given kind copy-on-write. Returns NULL if the
+//file is missing or was written for another configuration.
+PetscScalar* mapSetupCache(LocalData* data, const char* kind, int extra, int len,
+    void** base, size_t* mapLen);
+
+void unmapSetupCache(void* base, size_t mapLen);
+
+void writeSetupCache(LocalData* data, const char* kind, int extra,
+    const PetscScalar* vals, int len);
+
+//Interface couplings of this rank from the setup cache. Returns false (and
+//leaves the matrices alone) if the file is missing or does not match.
+bool loadInterfaceMatrixCache(LocalData* data);
+
+void writeInterfaceMatrixCache(LocalData* data);
+
+//kind names the MG level. The cached values are copied into J.
+bool loadMGmatrixCache(LocalData* data, const char* kind, Mat J);
+
+void writeMGmatrixCache(LocalData* data, const char* kind, Mat J);
+
+//Assembles and factors the dense low Schur complement (only if -explicit_schur is set)
+void createExplicitSchur(LocalData* data);
+
+void buildExplicitSchur(LocalData* data, bool isLow);
+
+//Probes the Schur operator to build a factored block-banded approximation
+//(only if -schur_probe_bandwidth is set)
+void createSchurProbe(LocalData* data);
+
+void buildSchurProbe(LocalData* data, bool isLow);
+
+void setInnerPC(LocalData* data, PC pc, bool isLow);
+
+PetscErrorCode lowSchurBandPCapply(void* ctx, Vec in, Vec out);
+
+PetscErrorCode highSchurBandPCapply(void* ctx, Vec in, Vec out);
+
+//The splits are placed to balance stripCost between the halves
+void createRSDtree(RSDnode *& root, const std::vector<double> & stripCost, int depth,
+    int x0, int rank, int npes);
+
+//Number of ranks in the low half of the level. The interface of the level
+//lies between ranks (levelSplitRank - 1) and levelSplitRank of the level.
+inline int levelSplitRank(RSDnode* node) {
+  return (node->split);
+}
+
+//Picks the number of columns of every rank (-strip_speeds, -strip_balance)
+void chooseStripWidths(LocalData* data);
 
 void destroyRSDtree(RSDnode *root);
 
+//Splits comm recursively along the tree and sets up the per-level solvers of
+//the nested-dissection mode
+void createNestedLevels(LocalData* data, RSDnode* node, MPI_Comm comm);
+
+void destroyNestedLevel(RSDnode* node);
+
+PetscErrorCode nestedSchurMatMult(Mat mat, Vec in, Vec out);
+
+PetscErrorCode nestedHalfMatMult(Mat mat, Vec in, Vec out);
+
+PetscErrorCode nestedHalfPCapply(void* ctx, Vec in, Vec out);
+
+void nestedHalfSolve(NDlevel* nd);
+
 void createLowAndHighComms(LocalData* data);
 
 //Uses S ordering
@@ -182,12 +689,143 @@ void schurMatVec(LocalData* data, bool isLow, Vec uSin, Vec uSout);
 //Uses S ordering
 void schurSolve(LocalData* data, bool isLow, Vec rhs, Vec sol);
 
+//Uses MG ordering. Solves with the local DMMG operator
+void localSolve(LocalData* data, Vec rhs, Vec sol);
+
+//Returns NULL if the stencil is not separable or N - 1 is not a power of 2
+FastLocalSolver* buildFastLocalSolver(int Nx, int N, int dofs, const std::vector<double> & nodeStencil);
+
+void fastSolveArrays(FastLocalSolver* fs, const double* rhs, double* sol);
+
+void createFastLocalSolver(LocalData* data);
+
+void destroyFastLocalSolver(LocalData* data);
+
+//Uses MG ordering
+void fastLocalSolve(LocalData* data, Vec rhs, Vec sol);
+
+double fastLocalSolverBytes(FastLocalSolver* fs);
+
 //Uses O ordering
 void KmatVec(LocalData* data, RSDnode* root, Vec uIn, Vec uOut);
 
 //Uses O ordering
 void RSDapplyInverse(LocalData* data, RSDnode* root, Vec f, Vec u);
 
+//Applies the selected RSD variant to the global vectors in and out
+void outerRSDapply(OuterContext* ctx, Vec in, Vec out);
+
+//Builds the coarse space if -coarse_space is set (ctx->coarse stays NULL
+//otherwise). Needs outerMat.
+void createCoarseSpace(OuterContext* ctx);
+
+void destroyCoarseSpace(OuterContext* ctx);
+
+//Builds the interface Schur solver if -interface_schur is set
+//(ctx->iface stays NULL otherwise)
+void createInterfaceSchur(OuterContext* ctx);
+
+void destroyInterfaceSchur(OuterContext* ctx);
+
+//Solves A sol = rhs (outer vectors) through the interface Schur complement.
+//Returns the number of interface iterations.
+int interfaceSchurSolve(OuterContext* ctx, Vec rhs, Vec sol);
+
+PetscErrorCode interfaceSchurMatMult(Mat mat, Vec in, Vec out);
+
+//Sets up the adaptive inner tolerances if -inner_adapt is set (ctx->adapt
+//stays NULL otherwise) and attaches innerAdaptMonitor to the outer KSPs
+void createInnerAdapt(OuterContext* ctx);
+
+void destroyInnerAdapt(OuterContext* ctx);
+
+//Sets the inner Schur tolerances for outer iteration it with residual norm
+//rnorm. Must be called with the same arguments on every rank.
+void updateInnerTolerances(OuterContext* ctx, int it, PetscReal rnorm);
+
+PetscErrorCode innerAdaptMonitor(KSP ksp, PetscInt it, PetscReal rnorm, void* ptr);
+
+//Total and maximum over ranks of the local solves since start
+void printLocalSolveCount(LocalData* data, long long start);
+
+PetscErrorCode interfaceSchurPCapply(void* ptr, Vec in, Vec out);
+
+//out = Phi (Phi^T A Phi)^{-1} Phi^T in. Global vectors.
+void coarseSolve(OuterContext* ctx, Vec in, Vec out);
+
+//RSD combined with the coarse correction (multiplicative unless
+//-coarse_additive). Global vectors.
+void coarseRSDapply(OuterContext* ctx, Vec in, Vec out);
+
+//Uses O ordering. The interface Schur complement of every level is solved
+//with all ranks of the subtree.
+void RSDapplyInverseNested(LocalData* data, RSDnode* root, Vec f, Vec u);
+
+//Uses O ordering. All interfaces are solved concurrently in two (even/odd) phases.
+void RSDapplyInverseAdditive(LocalData* data, Vec f, Vec u);
+
+//Block versions: k columns are pushed through together and each interface
+//message carries all k columns.
+
+//Uses S ordering
+void schurMatVecBlock(LocalData* data, bool isLow, int k, Vec* uSin, Vec* uSout);
+
+//Uses S ordering
+void schurSolveBlock(LocalData* data, bool isLow, int k, Vec* rhs, Vec* sol);
+
+//Uses O ordering
+void KmatVecBlock(LocalData* data, RSDnode* root, int k, Vec* uIn, Vec* uOut);
+
+//Uses O ordering
+void RSDapplyInverseBlock(LocalData* data, RSDnode* root, int k, Vec* f, Vec* u);
+
+//Uses MG ordering. Solves k columns with the local operator together.
+void localSolveBlock(LocalData* data, int k, Vec* rhs, Vec* sol);
+
+//Uses MG ordering. The tridiagonal sweeps run over all k columns.
+void fastLocalSolveBlock(LocalData* data, int k, Vec* rhs, Vec* sol);
+
+//The transforms and sweeps run in float if single is true
+void fastSolveBlockArrays(FastLocalSolver* fs, int k, const double* const* rhs, double* const* sol,
+    bool single);
+
+int blockFgmres(MPI_Comm comm, BlockKrylovOps* ops, BlockKrylovWork* work, int k, Vec* rhs,
+    Vec* sol, PetscReal rtol, PetscReal atol, int maxIts, int restart);
+
+void createBlockBuffers(LocalData* data);
+
+void destroyBlockBuffers(LocalData* data);
+
+//Solves with k right hand sides (outer vectors) at once
+void outerSolveBlock(OuterContext* ctx, int k, Vec* rhs, Vec* sol);
+
+//Solves again from a zero initial guess and returns the solve time
+double timedOuterSolve(OuterContext* ctx, PetscInt* iters);
+
+//Dot product of the locally owned entries (no reduction)
+PetscScalar localDot(Vec a, Vec b);
+
+//Pipelined FGMRES with the tolerances of outerKsp. One fused reduction per
+//iteration, overlapped with the next preconditioner and MatVec.
+int pipelinedFgmres(OuterContext* ctx, Vec rhs, Vec sol, bool* converged);
+
+//Outer solve with outerKsp, with pipelinedFgmres if -outer_pipelined is set
+//or through the interface Schur complement if -interface_schur is set.
+//Returns the number of iterations.
+int outerSolve(OuterContext* ctx, Vec rhs, Vec sol);
+
+//Wraps ctx (or a new OuterContext if ctx is NULL, which the solver then
+//owns). Reads -rsd_guess_order and -rsd_recycle.
+void createRSDSolver(RSDSolver* & solver, OuterContext* ctx);
+
+void destroyRSDSolver(RSDSolver* solver);
+
+//Solves A sol = rhs starting from the extrapolated guess. Returns the
+//number of outer iterations.
+int RSDSolve(RSDSolver* solver, Vec rhs, Vec sol);
+
+PetscErrorCode recyclePCapply(void* ptr, Vec in, Vec out);
+
 //This only sets the relevant values. It leaves the other values untouched.
 template<ListType fromType, ListType toType>
 inline void map(LocalData* data, Vec fromVec, Vec toVec);
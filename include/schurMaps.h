@@ -2,363 +2,157 @@
 #ifndef __SCHUR_MAPS__
 #define __SCHUR_MAPS__
 
-template<>
-inline void map<L, O>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
+//O and MG are stored x-major (node = (xi*N) + yi), so every interface
+//column is a contiguous run of N nodes and the owned block of MG is a
+//contiguous run of vnx columns. The offsets are in PetscScalars.
+//map<O, MG> and map<MG, O> write every entry of toVec (the columns that are
+//not copied are zeroed), so callers need not zero toVec first.
 
-  assert(rank < (npes - 1));
+inline void copyContiguous(LocalData* data, Vec fromVec, int fromOffset, Vec toVec, int toOffset, int len) {
+  profileBegin(data, PROF_MAP);
 
-  PetscScalar* oArr;
-  PetscScalar* lArr;
+  PetscScalar* fromArr;
+  PetscScalar* toArr;
 
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
-  } else {
-    oxs = 1;
-    onx = (data->N) - 1;
-  }
+  VecGetArray(fromVec, &fromArr);
+  VecGetArray(toVec, &toArr);
 
-  VecGetArray(fromVec, &lArr);
-  VecGetArray(toVec, &oArr);
+  PetscMemcpy((toArr + toOffset), (fromArr + fromOffset), (len*sizeof(PetscScalar)));
 
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      oArr[(((yi*onx) + ((data->N - 2) - oxs))*(data->dofsPerNode)) + d] = lArr[(yi*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
+  VecRestoreArray(fromVec, &fromArr);
+  VecRestoreArray(toVec, &toArr);
 
-  VecRestoreArray(fromVec, &lArr);
-  VecRestoreArray(toVec, &oArr);
+  profileEnd(data, PROF_MAP);
 }
 
-template<>
-inline void map<O, L>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
-
-  assert(rank < (npes - 1));
-
-  PetscScalar* oArr;
-  PetscScalar* lArr;
+//Number of scalars in one column of N nodes
+inline int columnSize(LocalData* data) {
+  return ((data->N)*(data->dofsPerNode));
+}
 
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
+//Number of columns copied between O and MG (excludes S)
+inline int numVolumeColumns(LocalData* data) {
+  if((data->rank) == ((data->npes) - 1)) {
+    return (data->onx);
   } else {
-    oxs = 1;
-    onx = (data->N) - 1;
+    return ((data->onx) - 1);
   }
-
-  VecGetArray(fromVec, &oArr);
-  VecGetArray(toVec, &lArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      lArr[(yi*(data->dofsPerNode)) + d] = oArr[(((yi*onx) + ((data->N - 2) - oxs))*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(fromVec, &oArr);
-  VecRestoreArray(toVec, &lArr);
 }
 
 template<>
-inline void map<H, O>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank;
-  MPI_Comm_rank(data->commAll, &rank);
-
-  assert(rank > 0);
+inline void map<L, O>(LocalData* data, Vec fromVec, Vec toVec) {
+  assert((data->rank) < ((data->npes) - 1));
 
-  PetscScalar* oArr;
-  PetscScalar* hArr;
+  copyContiguous(data, fromVec, 0, toVec, (((data->nx) - 2) - (data->oxs))*columnSize(data), columnSize(data));
+}
 
-  int oxs = 1;
-  int onx = (data->N) - 1;
+template<>
+inline void map<O, L>(LocalData* data, Vec fromVec, Vec toVec) {
+  assert((data->rank) < ((data->npes) - 1));
 
-  VecGetArray(fromVec, &hArr);
-  VecGetArray(toVec, &oArr);
+  copyContiguous(data, fromVec, (((data->nx) - 2) - (data->oxs))*columnSize(data), toVec, 0, columnSize(data));
+}
 
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      oArr[(((yi*onx) + (1 - oxs))*(data->dofsPerNode)) + d] = hArr[(yi*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
+template<>
+inline void map<H, O>(LocalData* data, Vec fromVec, Vec toVec) {
+  assert((data->rank) > 0);
 
-  VecRestoreArray(fromVec, &hArr);
-  VecRestoreArray(toVec, &oArr);
+  copyContiguous(data, fromVec, 0, toVec, (1 - (data->oxs))*columnSize(data), columnSize(data));
 }
 
 template<>
 inline void map<O, H>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank;
-  MPI_Comm_rank(data->commAll, &rank);
-
-  assert(rank > 0);
-
-  PetscScalar* oArr;
-  PetscScalar* hArr;
-
-  int oxs = 1;
-  int onx = (data->N) - 1;
-
-  VecGetArray(fromVec, &oArr);
-  VecGetArray(toVec, &hArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      hArr[(yi*(data->dofsPerNode)) + d] = oArr[(((yi*onx) + (1 - oxs))*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
+  assert((data->rank) > 0);
 
-  VecRestoreArray(fromVec, &oArr);
-  VecRestoreArray(toVec, &hArr);
+  copyContiguous(data, fromVec, (1 - (data->oxs))*columnSize(data), toVec, 0, columnSize(data));
 }
 
 template<>
 inline void map<O, S>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
-
-  assert(rank < (npes - 1));
+  assert((data->rank) < ((data->npes) - 1));
 
-  PetscScalar* oArr;
-  PetscScalar* sArr;
-
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
-  } else {
-    oxs = 1;
-    onx = (data->N) - 1;
-  }
-
-  VecGetArray(fromVec, &oArr);
-  VecGetArray(toVec, &sArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      sArr[(yi*(data->dofsPerNode)) + d] = oArr[(((yi*onx) + ((data->N - 1) - oxs))*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(fromVec, &oArr);
-  VecRestoreArray(toVec, &sArr);
+  copyContiguous(data, fromVec, (((data->nx) - 1) - (data->oxs))*columnSize(data), toVec, 0, columnSize(data));
 }
 
 template<>
 inline void map<S, O>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
-
-  assert(rank < (npes - 1));
+  assert((data->rank) < ((data->npes) - 1));
 
-  PetscScalar* oArr;
-  PetscScalar* sArr;
-
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
-  } else {
-    oxs = 1;
-    onx = (data->N) - 1;
-  }
-
-  VecGetArray(fromVec, &sArr);
-  VecGetArray(toVec, &oArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      oArr[(((yi*onx) + ((data->N - 1) - oxs))*(data->dofsPerNode)) + d] = sArr[(yi*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(fromVec, &sArr);
-  VecRestoreArray(toVec, &oArr);
+  copyContiguous(data, fromVec, 0, toVec, (((data->nx) - 1) - (data->oxs))*columnSize(data), columnSize(data));
 }
 
 template<>
 inline void map<MG, L>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
-
-  PetscScalar* mgArr;
-  PetscScalar* lArr;
-
-  assert(rank < (npes - 1));
-
-  VecGetArray(toVec, &lArr);
-  VecGetArray(fromVec, &mgArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      lArr[(yi*(data->dofsPerNode)) + d] = mgArr[(((yi*(data->N)) + (data->N - 2))*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
+  assert((data->rank) < ((data->npes) - 1));
 
-  VecRestoreArray(fromVec, &mgArr);
-  VecRestoreArray(toVec, &lArr);
+  copyContiguous(data, fromVec, ((data->nx) - 2)*columnSize(data), toVec, 0, columnSize(data));
 }
 
 template<>
 inline void map<L, MG>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
+  assert((data->rank) < ((data->npes) - 1));
 
-  PetscScalar* mgArr;
-  PetscScalar* lArr;
-
-  assert(rank < (npes - 1));
-
-  VecGetArray(fromVec, &lArr);
-  VecGetArray(toVec, &mgArr);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      mgArr[(((yi*(data->N)) + (data->N - 2))*(data->dofsPerNode)) + d] = lArr[(yi*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(toVec, &mgArr);
-  VecRestoreArray(fromVec, &lArr);
+  copyContiguous(data, fromVec, 0, toVec, ((data->nx) - 2)*columnSize(data), columnSize(data));
 }
 
 template<>
 inline void map<MG, H>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank;
-  MPI_Comm_rank(data->commAll, &rank);
-
-  PetscScalar* mgArr;
-  PetscScalar* hArr;
-
-  VecGetArray(toVec, &hArr);
-  VecGetArray(fromVec, &mgArr);
+  assert((data->rank) > 0);
 
-  assert(rank > 0);
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      hArr[(yi*(data->dofsPerNode)) + d] = mgArr[(((yi*(data->N)) + 1)*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(fromVec, &mgArr);
-  VecRestoreArray(toVec, &hArr);
+  copyContiguous(data, fromVec, columnSize(data), toVec, 0, columnSize(data));
 }
 
 template<>
 inline void map<H, MG>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank;
-  MPI_Comm_rank(data->commAll, &rank);
-
-  PetscScalar* mgArr;
-  PetscScalar* hArr;
-
-  VecGetArray(fromVec, &hArr);
-  VecGetArray(toVec, &mgArr);
-
-  assert(rank > 0);
+  assert((data->rank) > 0);
 
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int d = 0; d < (data->dofsPerNode); ++d) {
-      mgArr[(((yi*(data->N)) + 1)*(data->dofsPerNode)) + d] = hArr[(yi*(data->dofsPerNode)) + d];
-    }//end for d
-  }//end for yi
-
-  VecRestoreArray(toVec, &mgArr);
-  VecRestoreArray(fromVec, &hArr);
+  copyContiguous(data, fromVec, 0, toVec, columnSize(data), columnSize(data));
 }
 
 template<>
 inline void map<MG, O>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
+  profileBegin(data, PROF_MAP);
+
+  const int colSz = columnSize(data);
+  const int vnx = numVolumeColumns(data);
 
   PetscScalar* mgArr;
   PetscScalar* oArr;
 
-  VecGetArray(toVec, &oArr);
   VecGetArray(fromVec, &mgArr);
+  VecGetArray(toVec, &oArr);
 
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
-  } else {
-    oxs = 1;
-    onx = (data->N) - 1;
-  }
-
-  int vnx;
-  if(rank == (npes - 1)) {
-    vnx = onx;
-  } else {
-    vnx = onx - 1;
-  }
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int xi = oxs; xi < (oxs + vnx); ++xi) {
-      for(int d = 0; d < (data->dofsPerNode); ++d) {
-        oArr[(((yi*onx) + (xi - oxs))*(data->dofsPerNode)) + d] = mgArr[(((yi*(data->N)) + xi)*(data->dofsPerNode)) + d];
-      }//end for d
-    }//end for xi
-  }//end for yi
+  PetscMemcpy(oArr, (mgArr + ((data->oxs)*colSz)), (vnx*colSz*sizeof(PetscScalar)));
+  PetscMemzero((oArr + (vnx*colSz)), (((data->onx) - vnx)*colSz*sizeof(PetscScalar)));
 
   VecRestoreArray(fromVec, &mgArr);
   VecRestoreArray(toVec, &oArr);
+
+  profileEnd(data, PROF_MAP);
 }
 
 template<>
 inline void map<O, MG>(LocalData* data, Vec fromVec, Vec toVec) {
-  int rank, npes;
-  MPI_Comm_rank(data->commAll, &rank);
-  MPI_Comm_size(data->commAll, &npes);
+  profileBegin(data, PROF_MAP);
+
+  const int colSz = columnSize(data);
+  const int vnx = numVolumeColumns(data);
+  const int mgEnd = (data->oxs) + vnx;
 
-  PetscScalar* mgArr;
   PetscScalar* oArr;
+  PetscScalar* mgArr;
 
   VecGetArray(fromVec, &oArr);
   VecGetArray(toVec, &mgArr);
 
-  int oxs, onx;
-  if(rank == 0) {
-    oxs = 0;
-    onx = data->N;
-  } else {
-    oxs = 1;
-    onx = (data->N) - 1;
-  }
+  PetscMemzero(mgArr, ((data->oxs)*colSz*sizeof(PetscScalar)));
+  PetscMemcpy((mgArr + ((data->oxs)*colSz)), oArr, (vnx*colSz*sizeof(PetscScalar)));
+  PetscMemzero((mgArr + (mgEnd*colSz)), (((data->nx) - mgEnd)*colSz*sizeof(PetscScalar)));
 
-  int vnx;
-  if(rank == (npes - 1)) {
-    vnx = onx;
-  } else {
-    vnx = onx - 1;
-  }
-
-  for(int yi = 0; yi < (data->N); ++yi) {
-    for(int xi = oxs; xi < (oxs + vnx); ++xi) {
-      for(int d = 0; d < (data->dofsPerNode); ++d) {
-        mgArr[(((yi*(data->N)) + xi)*(data->dofsPerNode)) + d] = oArr[(((yi*onx) + (xi - oxs))*(data->dofsPerNode)) + d];
-      }//end for d
-    }//end for xi
-  }//end for yi
-
-  VecRestoreArray(toVec, &mgArr);
   VecRestoreArray(fromVec, &oArr);
+  VecRestoreArray(toVec, &mgArr);
+
+  profileEnd(data, PROF_MAP);
 }
 
 #endif
-